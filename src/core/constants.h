@@ -1,5 +1,7 @@
 #pragma once
 
+#include "vcp-feature.h"
+
 namespace Constants {
   namespace MCCS {
     // MCCS Version 2.1 and 2.2
@@ -32,20 +34,56 @@ namespace Constants {
     }     // namespace VCPCode
   }       // namespace MCCS
   namespace Display {
-    const short CONTINUOUS_FEATURE_MIN = 0;
+    constexpr short CONTINUOUS_FEATURE_MIN = 0;
 
     namespace Brightness {
-      const short MAX = 100;
-      const short DEFAULT = 50;
-      const short STEP = 10;
+      constexpr short MAX = 100;
+      constexpr short DEFAULT = 50;
+      constexpr short STEP = 10;
     } // namespace Brightness
 
     namespace Contrast {
-      const short MAX = 100;
-      const short DEFAULT = 50;
-      const short STEP = 5;
+      constexpr short MAX = 100;
+      constexpr short DEFAULT = 50;
+      constexpr short STEP = 5;
     } // namespace Contrast
 
-    const short REFRESH_INTERVAL = 10000; // 10 seconds, for performance
-  }                                      // namespace Display
+    constexpr short REFRESH_INTERVAL = 10000; // 10 seconds, for performance
+    constexpr short POPUP_IDLE_TIMEOUT = 300; // seconds closed before the popup is freed
+    constexpr int POPUP_IDLE_TIMEOUT_MAX = 24 * 60 * 60; // one day, fits the timer's int ms
+
+    constexpr int HISTORY_CAPACITY = 65536; // records of 16 bytes, 1 MiB history file
+    constexpr short HISTORY_VIEW_DAYS = 7;
+
+    // DRM connector of the controlled display, its `ddc` link points to the I2C bus
+    constexpr const char *DRM_CONNECTOR = "/sys/class/drm/card1-HDMI-A-1";
+
+    // Give up waiting for another process to release the bus, ddcutil still locks the device
+    constexpr short BUS_LOCK_TIMEOUT = 5000;
+    // Values read or written by any process within this time are used without touching the bus
+    constexpr short CACHE_MAX_AGE = REFRESH_INTERVAL / 2;
+
+    // Features controlled from the UI
+    namespace Feature {
+      inline constexpr VCP::FeatureDescriptor BRIGHTNESS{
+          MCCS::VCPCode::std::BRIGHTNESS, VCP::FeatureType::CONTINUOUS, CONTINUOUS_FEATURE_MIN,
+          Brightness::MAX,                Brightness::STEP,             Brightness::DEFAULT,
+          "Brightness: "};
+
+      inline constexpr VCP::FeatureDescriptor CONTRAST{
+          MCCS::VCPCode::std::CONTRAST, VCP::FeatureType::CONTINUOUS, CONTINUOUS_FEATURE_MIN,
+          Contrast::MAX,                Contrast::STEP,               Contrast::DEFAULT,
+          "Contrast: "};
+
+      // Range covers all known ModeValue entries, step is meaningless for a mode
+      inline constexpr VCP::FeatureDescriptor ACER_XV272UV3_MODE{
+          MCCS::VCPCode::Manufacturer::AcerXV272UV3::MODE,
+          VCP::FeatureType::NON_CONTINUOUS,
+          MCCS::VCPCode::Manufacturer::AcerXV272UV3::USER,
+          MCCS::VCPCode::Manufacturer::AcerXV272UV3::HDR,
+          0,
+          MCCS::VCPCode::Manufacturer::AcerXV272UV3::USER,
+          "Mode: "};
+    } // namespace Feature
+  }   // namespace Display
 } // namespace Constants
\ No newline at end of file
@@ -0,0 +1,219 @@
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "constants.h"
+#include "ddc-bus.h"
+
+namespace {
+  // Bump when the segment layout changes, old and new processes then use separate segments
+  constexpr int CACHE_VERSION = 1;
+  constexpr auto LOCK_POLL_INTERVAL = std::chrono::milliseconds(20);
+
+  struct CacheSegment {
+    // Timestamp in milliseconds << 16 | value, 0 when never written
+    std::array<std::atomic<std::uint64_t>, 256> slots;
+  };
+  static_assert(std::atomic<std::uint64_t>::is_always_lock_free,
+                "Cache slots must be lock-free to live in shared memory");
+
+  std::uint64_t monotonicMs() {
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+  }
+
+  // Documented in the README for other readers
+  QByteArray cacheSegmentName() {
+    return QStringLiteral("/display-vcp-v%1-%2-%3")
+        .arg(CACHE_VERSION)
+        .arg(getuid())
+        .arg(ddcBusName())
+        .toLocal8Bit();
+  }
+
+  CacheSegment *mapCacheSegment() {
+    const QByteArray name = cacheSegmentName();
+    int fd = shm_open(name.constData(), O_RDWR | O_CREAT | O_CLOEXEC, S_IRUSR | S_IWUSR);
+    if (fd == -1) {
+      qDebug() << "Failed to open the shared value cache:" << strerror(errno);
+      return nullptr;
+    }
+
+    // A new segment is zero filled, i.e. every slot is empty
+    void *addr = MAP_FAILED;
+    if (ftruncate(fd, sizeof(CacheSegment)) == 0)
+      addr = mmap(nullptr, sizeof(CacheSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (addr == MAP_FAILED) {
+      qDebug() << "Failed to map the shared value cache:" << strerror(errno);
+      return nullptr;
+    }
+    return static_cast<CacheSegment *>(addr);
+  }
+
+  // Mapped for the lifetime of the process
+  CacheSegment *cacheSegment() {
+    static CacheSegment *segment = mapCacheSegment();
+    return segment;
+  }
+
+  // Shared by every user where the system allows it, see the README
+  QString lockDirectory() {
+    if (access("/run/lock", W_OK) == 0)
+      return QStringLiteral("/run/lock");
+
+    QString runtimeDir = qEnvironmentVariable("XDG_RUNTIME_DIR");
+    return runtimeDir.isEmpty() ? QDir::tempPath() : runtimeDir;
+  }
+
+  // The directory may be world-writable, never follow a planted symlink or open a FIFO
+  int openLockFile(const char *path) {
+    constexpr int flags = O_NOFOLLOW | O_NONBLOCK | O_CLOEXEC;
+
+    int fd = open(path, O_RDWR | O_CREAT | O_EXCL | flags, 0666);
+    if (fd != -1) {
+      // Created by us, widen past the umask so that other users can lock it too
+      fchmod(fd, 0666);
+      return fd;
+    }
+    if (errno != EEXIST)
+      return -1;
+
+    // Created by someone else, flock() works on a read-only descriptor too
+    fd = open(path, O_RDWR | flags);
+    if (fd == -1)
+      fd = open(path, O_RDONLY | flags);
+    if (fd == -1)
+      return -1;
+
+    struct stat st {};
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+      close(fd);
+      errno = EINVAL;
+      return -1;
+    }
+    return fd;
+  }
+} // namespace
+
+const QString &ddcBusName() {
+  static const QString busName = []() {
+    QFileInfo ddcLink(QString(Constants::Display::DRM_CONNECTOR) + "/ddc");
+    if (ddcLink.isSymLink())
+      return QFileInfo(ddcLink.symLinkTarget()).fileName();
+
+    qDebug() << "No DDC bus link for" << Constants::Display::DRM_CONNECTOR;
+    return QStringLiteral("display-1");
+  }();
+  return busName;
+}
+
+BusLock::BusLock(int timeoutMs) {
+  const QByteArray path =
+      (lockDirectory() + "/display-vcp-" + ddcBusName() + ".lock").toLocal8Bit();
+
+  m_fd = openLockFile(path.constData());
+  if (m_fd == -1) {
+    qDebug() << "Failed to open the bus lock, continuing unlocked:" << path << strerror(errno);
+    return;
+  }
+
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+  while (flock(m_fd, LOCK_EX | LOCK_NB) != 0) {
+    if (errno != EWOULDBLOCK || std::chrono::steady_clock::now() >= deadline) {
+      // Best effort, ddcutil still locks the I2C device for the duration of each call
+      qDebug() << "Failed to lock the bus, continuing unlocked:" << strerror(errno);
+      return;
+    }
+    std::this_thread::sleep_for(LOCK_POLL_INTERVAL);
+  }
+  m_locked = true;
+}
+
+BusLock::~BusLock() {
+  // Closing the descriptor releases the lock
+  if (m_fd != -1)
+    close(m_fd);
+}
+
+namespace SharedValueCache {
+  short get(std::uint8_t code, int maxAgeMs) {
+    CacheSegment *segment = cacheSegment();
+    if (!segment)
+      return -1;
+
+    std::uint64_t slot = segment->slots[code].load(std::memory_order_acquire);
+    if (slot == 0 || monotonicMs() - (slot >> 16) > static_cast<std::uint64_t>(maxAgeMs))
+      return -1;
+
+    return static_cast<short>(slot & 0xFFFF);
+  }
+
+  void put(std::uint8_t code, short value) {
+    CacheSegment *segment = cacheSegment();
+    if (!segment || value == -1)
+      return;
+
+    segment->slots[code].store(monotonicMs() << 16 | static_cast<std::uint16_t>(value),
+                               std::memory_order_release);
+  }
+
+  void clear() {
+    CacheSegment *segment = cacheSegment();
+    if (!segment)
+      return;
+
+    for (auto &slot : segment->slots)
+      slot.store(0, std::memory_order_release);
+  }
+
+  bool readEntries(std::vector<Entry> &entries) {
+    const QByteArray name = cacheSegmentName();
+    int fd = shm_open(name.constData(), O_RDONLY | O_CLOEXEC, 0);
+    if (fd == -1) {
+      qDebug() << "Failed to open the shared value cache" << name << strerror(errno);
+      return false;
+    }
+
+    struct stat st {};
+    if (fstat(fd, &st) != 0 || st.st_size != sizeof(CacheSegment)) {
+      qDebug() << "Not a shared value cache of this version:" << name;
+      close(fd);
+      return false;
+    }
+
+    void *addr = mmap(nullptr, sizeof(CacheSegment), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+      qDebug() << "Failed to map the shared value cache:" << strerror(errno);
+      return false;
+    }
+
+    const auto *segment = static_cast<const CacheSegment *>(addr);
+    const std::uint64_t now = monotonicMs();
+    entries.clear();
+    for (std::size_t code = 0; code < segment->slots.size(); code++) {
+      std::uint64_t slot = segment->slots[code].load(std::memory_order_acquire);
+      if (slot != 0)
+        entries.push_back({static_cast<std::uint8_t>(code), static_cast<short>(slot & 0xFFFF),
+                           now - (slot >> 16)});
+    }
+
+    munmap(addr, sizeof(CacheSegment));
+    return true;
+  }
+} // namespace SharedValueCache
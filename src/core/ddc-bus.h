@@ -0,0 +1,92 @@
+#ifndef DDC_BUS_H
+#define DDC_BUS_H
+
+#include <QString>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief I2C bus name of the controlled display e.g. `"i2c-5"`
+ *
+ * Resolved once from the DRM connector, falls back to `"display-1"` when the connector has no
+ * `ddc` link.
+ */
+const QString &ddcBusName();
+
+/**
+ * @brief Advisory lock serializing DDC access to the bus between cooperating processes
+ *
+ * An exclusive `flock()` on `/run/lock/display-vcp-<bus>.lock`, or on the same file in
+ * `$XDG_RUNTIME_DIR` when `/run/lock` is not writable. Only processes taking this lock, e.g. scripts
+ * using `flock(1)` as described in the README, are serialized with the tray.
+ *
+ * ddcutil (2.x cross-instance locking) and libddcutil `flock()` the `/dev/i2c-N` device while
+ * they talk to it. Holding that lock ourselves would block the ddcutil child process, so the
+ * device lock is left to ddcutil. That device lock is also what remains when this lock cannot be
+ * taken within the timeout and the call continues unlocked.
+ */
+class BusLock {
+public:
+  /**
+   * @param timeoutMs Give up waiting after this many milliseconds and continue unlocked, check
+   *                  `isLocked()`
+   */
+  explicit BusLock(int timeoutMs);
+  ~BusLock();
+
+  BusLock(const BusLock &) = delete;
+  BusLock &operator=(const BusLock &) = delete;
+
+  bool isLocked() const { return m_locked; }
+
+private:
+  int m_fd{-1};
+  bool m_locked{false};
+};
+
+/**
+ * @brief Last known VCP values of the bus, shared between processes of the same user
+ *
+ * Backed by a POSIX shared memory segment holding one lock-free slot per VCP code, each slot
+ * packing the value with its `CLOCK_MONOTONIC` timestamp. The format is described in the README.
+ */
+namespace SharedValueCache {
+  /**
+   * @brief Get a cached value
+   *
+   * @param code VCP code
+   * @param maxAgeMs Oldest acceptable value in milliseconds
+   * @return cached value, `-1` when missing, stale or the cache is unavailable
+   */
+  short get(std::uint8_t code, int maxAgeMs);
+
+  /**
+   * @brief Store a value read from or written to the display
+   *
+   * @param code VCP code
+   * @param value Value in decimal format
+   */
+  void put(std::uint8_t code, short value);
+
+  /**
+   * @brief Forget every cached value, e.g. after a mode change altered other features
+   */
+  void clear();
+
+  struct Entry {
+    std::uint8_t code;
+    short value;
+    // Time since the value was stored, in milliseconds
+    std::uint64_t ageMs;
+  };
+
+  /**
+   * @brief Copy of every stored value regardless of its age, without creating the segment
+   *
+   * @param entries Set to the stored values, by VCP code
+   * @return false if the segment is missing or from another version, `entries` is then unchanged
+   */
+  bool readEntries(std::vector<Entry> &entries);
+} // namespace SharedValueCache
+
+#endif
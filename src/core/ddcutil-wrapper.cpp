@@ -1,108 +1,88 @@
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QProcess>
-#include <QtConcurrent/QtConcurrent>
 
-short getVCPValue(QString vcpCode) {
-  vcpCode = vcpCode.toUpper();
+#include "constants.h"
+#include "ddc-bus.h"
+#include "ddcutil-wrapper.h"
+#include "history.h"
 
-  QProcess process;
-  QString command = "ddcutil";
-  QStringList arguments = {"--display=1", "--terse", "getvcp", vcpCode};
-
-  // process.start("ls", QStringList() << "-l");
-  process.start(command, arguments);
-  process.waitForFinished();
-
-  if (process.exitCode() != 0)
-    return -1;
-
-  // https://www.ddcutil.com/command_getvcp/#option-terse-brief
-  QString output = process.readAllStandardOutput();
+namespace detail {
+  QStringList getVCPArguments(const VCP::FeatureDescriptor &feature) {
+    return {"--display=1", "--terse", "getvcp", QLatin1StringView(feature.hexCode.data())};
+  }
 
-  // Simple Non-continuous => VCP feature-code SNC hex-value
-  if (output.contains("VCP " + vcpCode + " SNC")) {
-    QStringList parts = output.split("VCP " + vcpCode + " SNC");
-    if (parts.size() > 1) {
-      QString value = parts[1].trimmed().split(" ").first().split("x").last();
-      return value.toShort(nullptr, 16);
+  short getVCPValue(const VCP::FeatureDescriptor &feature, const QStringList &arguments,
+                    TerseParser parse) {
+    short value = SharedValueCache::get(feature.code, Constants::Display::CACHE_MAX_AGE);
+    if (value != -1) {
+      History::recordValue(feature.code, value);
+      return value;
     }
-  }
 
-  // Complex Non-continuous => VCP feature-code CNC mh-hex ml-hex sh-hex sl-hex
-  if (output.contains("VCP " + vcpCode + " CNC")) {
-    QStringList parts = output.split("VCP " + vcpCode + " CNC");
+    BusLock lock(Constants::Display::BUS_LOCK_TIMEOUT);
 
-    if (parts.size() > 1) {
-      QStringList values = parts[1].trimmed().split(" ");
-      if (values.size() > 0) {
-        QString highByte = values[2].split("x")[1];                                 // sh-hex
-        QString lowByte = values[3].split("x")[1];                                  // sl-hex
-        return (highByte.toShort(nullptr, 16) << 8) + lowByte.toShort(nullptr, 16); // set value
-      }
+    // Another process may have read the value while we were waiting for the bus
+    value = SharedValueCache::get(feature.code, Constants::Display::CACHE_MAX_AGE);
+    if (value != -1) {
+      History::recordValue(feature.code, value);
+      return value;
     }
-  }
 
-  // Continuous [0, max-value] => VCP feature-code C cur-value-decimal max-value-decimal
-  if (output.contains("VCP " + vcpCode + " C")) {
-    QStringList parts = output.split("VCP " + vcpCode + " C");
-    if (parts.size() > 1) {
-      QStringList values = parts[1].trimmed().split(" ");
-      if (values.size() > 0) {
-        QString value = values.first();
-        return value.toShort();
-      }
-    }
-  }
+    QProcess process;
+    QString command = "ddcutil";
 
-  // // Table VCP code => VCP feature-code T hex-string
-  // if (output.contains("VCP " + vcpCode + " T")) {
-  //   QStringList parts = output.split("T");
-  //   if (parts.size() > 1) {
-  //     QString value = parts[1].trimmed();
-  //     return value;
-  //   }
-  // }
+    QElapsedTimer elapsed;
+    elapsed.start();
+    process.start(command, arguments);
+    process.waitForFinished();
 
-  // Unknown format
-  return -1;
-}
+    if (process.exitCode() != 0) {
+      History::recordLatency(History::Kind::GET_FAILED, feature.code, -1, elapsed.elapsed());
+      return -1;
+    }
 
-int setVCPValue(QString vcpCode, short value) {
-  QProcess process;
-  QString command = "ddcutil";
-  QStringList arguments = {"--display=1", "setvcp", vcpCode, QString::number(value)};
+    const QByteArray output = process.readAllStandardOutput();
+    value = parse(output);
+    History::recordLatency(value == -1 ? History::Kind::GET_FAILED : History::Kind::GET,
+                           feature.code, value, elapsed.elapsed());
+    History::recordValue(feature.code, value);
+    SharedValueCache::put(feature.code, value);
+    return value;
+  }
 
-  process.start(command, arguments);
-  if (process.waitForFinished()) {
-    if (process.exitCode() != 0)
+  int setVCPValue(const VCP::FeatureDescriptor &feature, short value) {
+    QProcess process;
+    QString command = "ddcutil";
+    QStringList arguments = {"--display=1", "setvcp", QLatin1StringView(feature.hexCode.data()),
+                             QString::number(value)};
+
+    BusLock lock(Constants::Display::BUS_LOCK_TIMEOUT);
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+    process.start(command, arguments);
+    bool finished = process.waitForFinished();
+    bool succeeded = finished && process.exitStatus() == QProcess::NormalExit &&
+                     process.exitCode() == 0;
+    History::recordLatency(succeeded ? History::Kind::SET : History::Kind::SET_FAILED, feature.code,
+                           value, elapsed.elapsed());
+
+    // The history and the caller must agree, never report an unconfirmed value as set
+    if (!succeeded) {
+      if (!finished || process.exitStatus() != QProcess::NormalExit) {
+        qDebug() << "Failed to run the process:" << process.errorString();
+        return -1;
+      }
       qDebug() << "Failed to set VCP value:" << process.readAllStandardError();
-  } else
-    qDebug() << "Failed to start the process:" << process.errorString();
-
-  return process.exitCode();
-}
-
-void getVCPValueAsync(QString vcpCode, std::function<void(short)> callback) {
-  auto *watcher = new QFutureWatcher<short>();
-  QObject::connect(watcher, &QFutureWatcher<short>::finished, watcher, [watcher, callback]() {
-    short result = watcher->result();
-    callback(result);
-    watcher->deleteLater();
-  });
-
-  // Watcher is on the main/UI thread
-  watcher->setFuture(
-      // Execute getVCPValue in a worker thread
-      QtConcurrent::run(getVCPValue, vcpCode));
-}
-
-void setVCPValueAsync(QString vcpCode, short value, std::function<void(int)> callback) {
-  auto *watcher = new QFutureWatcher<int>();
-  QObject::connect(watcher, &QFutureWatcher<int>::finished, watcher, [watcher, callback]() {
-    int result = watcher->result();
-    callback(result);
-    watcher->deleteLater();
-  });
+      return process.exitCode();
+    }
 
-  watcher->setFuture(QtConcurrent::run(setVCPValue, vcpCode, value));
-}
\ No newline at end of file
+    History::recordValue(feature.code, value);
+    // Non-continuous features like the display mode may change other features too
+    if (feature.type == VCP::FeatureType::NON_CONTINUOUS)
+      SharedValueCache::clear();
+    SharedValueCache::put(feature.code, value);
+    return 0;
+  }
+} // namespace detail
@@ -1,40 +1,172 @@
 #ifndef DDCUTIL_WRAPPER_H
 #define DDCUTIL_WRAPPER_H
 
+#include <QByteArrayView>
+#include <QObject>
 #include <QString>
+#include <QStringList>
+#include <array>
+
+#include "task.h"
+#include "vcp-feature.h"
+
+// Internals of the per feature entry points below, not to be called directly
+namespace detail {
+  // Split off the next space separated field of a terse response without copying
+  inline QByteArrayView nextField(QByteArrayView &rest) {
+    rest = rest.trimmed();
+    qsizetype end = rest.indexOf(' ');
+    if (end < 0)
+      end = rest.size();
+
+    QByteArrayView field = rest.first(end);
+    rest = rest.sliced(end);
+    return field;
+  }
+
+  // Non-continuous values are printed as `x<hex>`
+  inline short hexField(QByteArrayView field, bool *ok) {
+    if (!field.startsWith('x')) {
+      *ok = false;
+      return 0;
+    }
+    return field.sliced(1).toShort(ok, 16);
+  }
+
+  // https://www.ddcutil.com/command_getvcp/#option-terse-brief
+  template <const VCP::FeatureDescriptor &Feature> short parseTerseValue(QByteArrayView output) {
+    static_assert(Feature.type != VCP::FeatureType::TABLE, "Table features are not supported");
+    constexpr QByteArrayView prefix(Feature.responsePrefix.data(),
+                                    Feature.responsePrefix.size() - 1);
+
+    qsizetype start = output.indexOf(prefix);
+    if (start < 0)
+      return -1;
+
+    QByteArrayView rest = output.sliced(start + prefix.size());
+    QByteArrayView type = nextField(rest);
+    bool ok = false;
+
+    if constexpr (Feature.type == VCP::FeatureType::CONTINUOUS) {
+      // Continuous [0, max-value] => VCP feature-code C cur-value-decimal max-value-decimal
+      if (type == "C") {
+        short value = nextField(rest).toShort(&ok);
+        return ok ? value : -1;
+      }
+    } else {
+      // Simple Non-continuous => VCP feature-code SNC hex-value
+      if (type == "SNC") {
+        short value = hexField(nextField(rest), &ok);
+        return ok ? value : -1;
+      }
+
+      // Complex Non-continuous => VCP feature-code CNC mh-hex ml-hex sh-hex sl-hex
+      if (type == "CNC") {
+        nextField(rest); // mh-hex
+        nextField(rest); // ml-hex
+        bool okLow = false;
+        short highByte = hexField(nextField(rest), &ok);    // sh-hex
+        short lowByte = hexField(nextField(rest), &okLow); // sl-hex
+        return ok && okLow ? (highByte << 8) + lowByte : -1; // set value
+      }
+    }
+
+    // Unknown format
+    return -1;
+  }
+
+  using TerseParser = short (*)(QByteArrayView output);
+
+  /**
+   * @brief Build the ddcutil arguments to read a feature
+   *
+   * @param feature Feature to read
+   * @return Arguments for `ddcutil`
+   */
+  QStringList getVCPArguments(const VCP::FeatureDescriptor &feature);
+
+  /**
+   * @brief Get the VCP value using ddcutil
+   *
+   * @param feature Feature to read
+   * @param arguments Arguments built by `getVCPArguments` for the same feature
+   * @param parse `parseTerseValue` instantiated for the same feature
+   * @return set VCP value in decimal format, `-1` on failure
+   */
+  short getVCPValue(const VCP::FeatureDescriptor &feature, const QStringList &arguments,
+                    TerseParser parse);
+
+  /**
+   * @brief Set the VCP value using ddcutil
+   *
+   * @param feature Feature to write
+   * @param value Value to set in decimal format
+   * @return int Exit code of the process, `-1` if it did not run to completion
+   */
+  int setVCPValue(const VCP::FeatureDescriptor &feature, short value);
+
+  // The ddcutil arguments are built once per feature
+  template <const VCP::FeatureDescriptor &Feature> const QStringList &getVCPArguments() {
+    static const QStringList arguments = getVCPArguments(Feature);
+    return arguments;
+  }
+} // namespace detail
 
 /**
  * @brief Get the VCP value using ddcutil
  *
- * @param vcpCode VCP code in hexadecimal format e.g. `"E2"`
- * @return set VCP value in decimal format
+ * @return set VCP value in decimal format, `-1` on failure
  */
-short getVCPValue(QString vcpCode);
+template <const VCP::FeatureDescriptor &Feature> short getVCPValue() {
+  static_assert(Feature.type != VCP::FeatureType::TABLE, "Table features are not supported");
+  return detail::getVCPValue(Feature, detail::getVCPArguments<Feature>(),
+                             &detail::parseTerseValue<Feature>);
+}
 
 /**
  * @brief Set the VCP value using ddcutil
  *
- * @param vcpCode VCP code in hexadecimal format e.g. `"E2"`
  * @param value Value to set in decimal format
- * @return int Exit code of the process
+ * @return int Exit code of the process, `-1` if it did not run to completion
+ */
+template <const VCP::FeatureDescriptor &Feature> int setVCPValue(short value) {
+  static_assert(Feature.type != VCP::FeatureType::TABLE, "Table features are not supported");
+  return detail::setVCPValue(Feature, value);
+}
+
+/**
+ * @brief Get the VCP value in a worker thread, `co_await` it from a `Task`
+ *
+ * @param context The awaiting coroutine is dropped if this object is destroyed first
+ * @return awaitable resulting in the value, see `getVCPValue`
  */
-int setVCPValue(QString vcpCode, short value);
+template <const VCP::FeatureDescriptor &Feature> auto getVCPValueAsync(QObject *context) {
+  return AsyncWork(context, []() { return getVCPValue<Feature>(); });
+}
 
 /**
- * @brief Get the VCP value asynchronously using ddcutil
+ * @brief Get several VCP values one after the other in a single worker thread hop
  *
- * @param vcpCode VCP code in hexadecimal format e.g. `"E2"`
- * @param callback Function to call with the retrieved value
+ * @param context The awaiting coroutine is dropped if this object is destroyed first
+ * @return awaitable resulting in the values, in the order of `Features`
  */
-void getVCPValueAsync(QString vcpCode, std::function<void(short)> callback);
+template <const VCP::FeatureDescriptor &...Features> auto getVCPValuesAsync(QObject *context) {
+  return AsyncWork(context, []() {
+    // Braced initializers are evaluated in order
+    return std::array<short, sizeof...(Features)>{getVCPValue<Features>()...};
+  });
+}
 
 /**
- * @brief Set the VCP value asynchronously using ddcutil
+ * @brief Set the VCP value in a worker thread, `co_await` it from a `Task`
  *
- * @param vcpCode VCP code in hexadecimal format e.g. `"E2"`
+ * @param context The awaiting coroutine is dropped if this object is destroyed first
  * @param value Value to set in decimal format
- * @param callback Function to call with the exit code
+ * @return awaitable resulting in the exit code, see `setVCPValue`
  */
-void setVCPValueAsync(QString vcpCode, short value, std::function<void(int)> callback);
+template <const VCP::FeatureDescriptor &Feature>
+auto setVCPValueAsync(QObject *context, short value) {
+  return AsyncWork(context, [value]() { return setVCPValue<Feature>(value); });
+}
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,34 @@
+#include <QFile>
+
+#include "diagnostics.h"
+
+ProcessStats processStats() {
+  ProcessStats stats;
+
+  QFile status("/proc/self/status");
+  if (!status.open(QIODevice::ReadOnly | QIODevice::Text))
+    return stats;
+
+  // Lines look like `VmRSS:      12345 kB`
+  for (const QByteArray &line : status.readAll().split('\n')) {
+    QList<QByteArray> fields = line.simplified().split(' ');
+    if (fields.size() < 2)
+      continue;
+
+    if (fields[0] == "VmRSS:")
+      stats.rssKiB = fields[1].toLongLong();
+    else if (fields[0] == "voluntary_ctxt_switches:")
+      stats.voluntaryContextSwitches = fields[1].toLongLong();
+    else if (fields[0] == "nonvoluntary_ctxt_switches:")
+      stats.involuntaryContextSwitches = fields[1].toLongLong();
+  }
+
+  return stats;
+}
+
+QDebug operator<<(QDebug debug, const ProcessStats &stats) {
+  QDebugStateSaver saver(debug);
+  debug.nospace() << "RSS: " << stats.rssKiB << " KiB, wakeups: " << stats.voluntaryContextSwitches
+                  << " (+" << stats.involuntaryContextSwitches << " preempted)";
+  return debug;
+}
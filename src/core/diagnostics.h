@@ -0,0 +1,26 @@
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include <QDebug>
+
+/**
+ * @brief Resource usage of this process, from `/proc/self/status`
+ */
+struct ProcessStats {
+  // Resident set size in KiB
+  qint64 rssKiB{-1};
+  // Times the process slept and was woken up again, i.e. its wakeups
+  qint64 voluntaryContextSwitches{-1};
+  qint64 involuntaryContextSwitches{-1};
+};
+
+/**
+ * @brief Read the current resource usage
+ *
+ * @return stats, fields are `-1` when unavailable
+ */
+ProcessStats processStats();
+
+QDebug operator<<(QDebug debug, const ProcessStats &stats);
+
+#endif
@@ -0,0 +1,231 @@
+#include <QDebug>
+#include <QDir>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "constants.h"
+#include "ddc-bus.h"
+#include "history.h"
+
+namespace {
+  constexpr std::uint32_t HISTORY_MAGIC = 0x48504356; // "VCPH"
+  // Bump when the file layout changes, the history is then started over
+  constexpr std::uint32_t HISTORY_VERSION = 1;
+
+  struct HistoryHeader {
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint32_t capacity;
+    std::uint32_t reserved;
+    // Total number of records ever appended, the next slot is `next % capacity`
+    std::atomic<std::uint64_t> next;
+    // Last recorded value per VCP code, `-1` if none
+    std::array<std::atomic<std::int16_t>, 256> lastValues;
+  };
+  static_assert(std::atomic<std::uint64_t>::is_always_lock_free &&
+                    std::atomic<std::int16_t>::is_always_lock_free,
+                "History counters must be lock-free to live in a mapped file");
+  static_assert(std::atomic_ref<std::int64_t>::is_always_lock_free,
+                "Record times must be lock-free to be loaded from a read-only mapping");
+
+  struct HistoryFile {
+    HistoryHeader header;
+    History::Record records[Constants::Display::HISTORY_CAPACITY];
+  };
+
+  QString historyDirectory() {
+    // https://specifications.freedesktop.org/basedir-spec/latest/
+    QString stateHome = qEnvironmentVariable("XDG_STATE_HOME");
+    if (stateHome.isEmpty())
+      stateHome = QDir::homePath() + "/.local/state";
+    return stateHome + "/display-vcp";
+  }
+
+  // One file per bus, the VCP codes of different displays must not mix
+  QString historyPath() { return historyDirectory() + "/history-" + ddcBusName() + ".bin"; }
+
+  bool isCompatible(const HistoryHeader &header) {
+    return header.magic == HISTORY_MAGIC && header.version == HISTORY_VERSION &&
+           header.capacity == Constants::Display::HISTORY_CAPACITY;
+  }
+
+  HistoryFile *mapHistoryFile() {
+    const QString directory = historyDirectory();
+    if (!QDir().mkpath(directory)) {
+      qDebug() << "Failed to create" << directory;
+      return nullptr;
+    }
+
+    const QByteArray path = historyPath().toLocal8Bit();
+    int fd = open(path.constData(), O_RDWR | O_CREAT | O_CLOEXEC, S_IRUSR | S_IWUSR);
+    if (fd == -1) {
+      qDebug() << "Failed to open the history" << path << strerror(errno);
+      return nullptr;
+    }
+
+    struct stat st {};
+    if (fstat(fd, &st) != 0) {
+      qDebug() << "Failed to stat the history:" << strerror(errno);
+      close(fd);
+      return nullptr;
+    }
+
+    bool resized = st.st_size != sizeof(HistoryFile);
+    if (resized && ftruncate(fd, sizeof(HistoryFile)) != 0) {
+      qDebug() << "Failed to resize the history:" << strerror(errno);
+      close(fd);
+      return nullptr;
+    }
+
+    void *addr = mmap(nullptr, sizeof(HistoryFile), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+      qDebug() << "Failed to map the history:" << strerror(errno);
+      return nullptr;
+    }
+
+    auto *file = static_cast<HistoryFile *>(addr);
+    HistoryHeader &header = file->header;
+    if (resized || !isCompatible(header)) {
+      // New or incompatible file, start over
+      std::memset(file->records, 0, sizeof(file->records));
+      header.next.store(0);
+      for (auto &lastValue : header.lastValues)
+        lastValue.store(-1);
+      header.capacity = Constants::Display::HISTORY_CAPACITY;
+      header.version = HISTORY_VERSION;
+      header.magic = HISTORY_MAGIC;
+    }
+    return file;
+  }
+
+  // Mapped for the lifetime of the process
+  HistoryFile *historyFile() {
+    static HistoryFile *file = mapHistoryFile();
+    return file;
+  }
+
+  void append(History::Kind kind, std::uint8_t code, short value, qint64 latencyMs) {
+    HistoryFile *file = historyFile();
+    if (!file)
+      return;
+
+    using namespace std::chrono;
+    std::uint64_t index = file->header.next.fetch_add(1, std::memory_order_relaxed);
+    History::Record &record = file->records[index % Constants::Display::HISTORY_CAPACITY];
+
+    // The time marks the slot as complete, readers skip it while it is 0
+    std::atomic_ref<std::int64_t> timeMs(record.timeMs);
+    timeMs.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    record.code = code;
+    record.kind = kind;
+    record.value = value;
+    record.latencyMs = static_cast<std::int32_t>(latencyMs);
+    timeMs.store(duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count(),
+                 std::memory_order_release);
+  }
+
+  // Complete records, oldest first. Only loads from `file`, it may be mapped read-only
+  std::vector<History::Record> copyRecords(HistoryFile &file) {
+    const std::uint64_t next = file.header.next.load(std::memory_order_relaxed);
+    const std::uint64_t count =
+        std::min<std::uint64_t>(next, Constants::Display::HISTORY_CAPACITY);
+
+    std::vector<History::Record> result;
+    result.reserve(count);
+    for (std::uint64_t index = next - count; index < next; index++) {
+      History::Record &slot = file.records[index % Constants::Display::HISTORY_CAPACITY];
+      std::atomic_ref<std::int64_t> timeMs(slot.timeMs);
+
+      // Skip a slot that is being written meanwhile
+      std::int64_t before = timeMs.load(std::memory_order_acquire);
+      History::Record record = slot;
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (before != 0 && timeMs.load(std::memory_order_relaxed) == before)
+        result.push_back(record);
+    }
+    return result;
+  }
+} // namespace
+
+namespace History {
+  void recordValue(std::uint8_t code, short value) {
+    HistoryFile *file = historyFile();
+    if (!file || value == -1)
+      return;
+
+    if (file->header.lastValues[code].exchange(value, std::memory_order_relaxed) != value)
+      append(Kind::VALUE, code, value, 0);
+  }
+
+  void recordLatency(Kind kind, std::uint8_t code, short value, qint64 latencyMs) {
+    append(kind, code, value, latencyMs);
+  }
+
+  std::vector<Record> records() {
+    HistoryFile *file = historyFile();
+    if (!file)
+      return {};
+    return copyRecords(*file);
+  }
+
+  bool readRecords(std::vector<Record> &records) {
+    const QByteArray path = historyPath().toLocal8Bit();
+    int fd = open(path.constData(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+      qDebug() << "Failed to open the history" << path << strerror(errno);
+      return false;
+    }
+
+    struct stat st {};
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size != sizeof(HistoryFile)) {
+      qDebug() << "Not a history file of this version:" << path;
+      close(fd);
+      return false;
+    }
+
+    void *addr = mmap(nullptr, sizeof(HistoryFile), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+      qDebug() << "Failed to map the history:" << strerror(errno);
+      return false;
+    }
+
+    auto *file = static_cast<HistoryFile *>(addr);
+    bool compatible = isCompatible(file->header);
+    if (compatible)
+      records = copyRecords(*file);
+    else
+      qDebug() << "Not a history file of this version:" << path;
+
+    munmap(addr, sizeof(HistoryFile));
+    return compatible;
+  }
+
+  const char *kindName(Kind kind) {
+    switch (kind) {
+    case Kind::VALUE:
+      return "VALUE";
+    case Kind::GET:
+      return "GET";
+    case Kind::GET_FAILED:
+      return "GET_FAILED";
+    case Kind::SET:
+      return "SET";
+    case Kind::SET_FAILED:
+      return "SET_FAILED";
+    }
+    return "UNKNOWN";
+  }
+} // namespace History
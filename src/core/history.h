@@ -0,0 +1,75 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <QtGlobal>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Long-term history of VCP values and ddcutil latencies
+ *
+ * Kept in a fixed-size ring buffer file per bus, `$XDG_STATE_HOME/display-vcp/history-<bus>.bin`
+ * (see `ddcBusName`), mapped into memory once. Appending a record only writes to the mapping, the
+ * oldest records are overwritten.
+ */
+namespace History {
+  enum class Kind : std::uint8_t {
+    VALUE,      // Observed value change
+    GET,        // getvcp latency
+    GET_FAILED, // getvcp latency, no value
+    SET,        // setvcp latency
+    SET_FAILED, // setvcp latency, non-zero exit code
+  };
+
+  struct Record {
+    // Wall clock, milliseconds since epoch. 0 for an unused slot
+    std::int64_t timeMs;
+    std::uint8_t code;
+    Kind kind;
+    // Observed, read or written value, `-1` if unknown
+    std::int16_t value;
+    // Duration of the ddcutil call, 0 for value changes
+    std::int32_t latencyMs;
+  };
+  static_assert(sizeof(Record) == 16);
+
+  /**
+   * @brief Record a value if it differs from the last one recorded for the code
+   *
+   * @param code VCP code
+   * @param value Value in decimal format
+   */
+  void recordValue(std::uint8_t code, short value);
+
+  /**
+   * @brief Record how long a ddcutil call took
+   *
+   * @param kind One of the latency kinds
+   * @param code VCP code
+   * @param value Value read or written, `-1` if unknown
+   * @param latencyMs Duration in milliseconds
+   */
+  void recordLatency(Kind kind, std::uint8_t code, short value, qint64 latencyMs);
+
+  /**
+   * @brief Copy of all records
+   *
+   * @return records, oldest first
+   */
+  std::vector<Record> records();
+
+  /**
+   * @brief Copy of all records, without creating, resizing or resetting the history file
+   *
+   * @param records Set to the records, oldest first
+   * @return false if the file is missing or from another version, `records` is then unchanged
+   */
+  bool readRecords(std::vector<Record> &records);
+
+  /**
+   * @brief Short name of a kind e.g. `"GET"`
+   */
+  const char *kindName(Kind kind);
+} // namespace History
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef TASK_H
+#define TASK_H
+
+#include <QFutureWatcher>
+#include <QPointer>
+#include <QtConcurrent/QtConcurrent>
+
+#include <coroutine>
+#include <exception>
+#include <type_traits>
+
+/**
+ * @brief Fire-and-forget coroutine running on the GUI thread
+ *
+ * Starts right away and frees itself once it returns. Blocking calls are awaited through
+ * `AsyncWork`, which resumes the coroutine on the GUI thread.
+ */
+struct Task {
+  struct promise_type {
+    Task get_return_object() noexcept { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() noexcept {}
+    void unhandled_exception() noexcept { std::terminate(); }
+  };
+};
+
+/**
+ * @brief Awaitable running `work` in a worker thread
+ *
+ * The awaiting coroutine is resumed on the GUI thread with the result of `work`. If `context` is
+ * destroyed before `work` finishes, the coroutine is destroyed instead of resumed.
+ */
+template <typename Work> class AsyncWork {
+  using Result = std::invoke_result_t<Work>;
+
+public:
+  AsyncWork(QObject *context, Work work) : m_context(context), m_work(std::move(work)) {}
+
+  bool await_ready() const noexcept { return false; }
+
+  void await_suspend(std::coroutine_handle<> handle) {
+    auto *watcher = new QFutureWatcher<Result>();
+    QObject::connect(watcher, &QFutureWatcher<Result>::finished, watcher,
+                     [this, watcher, handle]() {
+                       watcher->deleteLater();
+
+                       if (!m_context) {
+                         handle.destroy();
+                         return;
+                       }
+                       m_result = watcher->result();
+                       handle.resume();
+                     });
+
+    // Watcher is on the main/UI thread
+    watcher->setFuture(QtConcurrent::run(std::move(m_work)));
+  }
+
+  Result await_resume() { return std::move(m_result); }
+
+private:
+  QPointer<QObject> m_context;
+  Work m_work;
+  Result m_result{};
+};
+
+#endif
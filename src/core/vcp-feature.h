@@ -0,0 +1,52 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace VCP {
+  /**
+   * MCCS feature types, as reported by `ddcutil --terse getvcp`
+   * https://www.ddcutil.com/command_getvcp/#option-terse-brief
+   */
+  enum class FeatureType : std::uint8_t {
+    CONTINUOUS,     // C
+    NON_CONTINUOUS, // SNC / CNC
+    TABLE,          // T
+  };
+
+  namespace detail {
+    constexpr char hexDigit(unsigned value) { return "0123456789ABCDEF"[value & 0xF]; }
+  } // namespace detail
+
+  /**
+   * @brief Compile-time description of a single VCP feature
+   *
+   * All strings needed to talk to ddcutil are formatted at compile time, so the get/set path
+   * never has to build them from the numeric code.
+   */
+  struct FeatureDescriptor {
+    constexpr FeatureDescriptor(std::uint8_t code, FeatureType type, short min, short max,
+                                short step, short defaultValue, const char *label)
+        : code(code), type(type), min(min), max(max), step(step), defaultValue(defaultValue),
+          label(label), hexCode{detail::hexDigit(code >> 4), detail::hexDigit(code), '\0'},
+          responsePrefix{'V', 'C', 'P', ' ', hexCode[0], hexCode[1], ' ', '\0'} {}
+
+    std::uint8_t code;
+    FeatureType type;
+    short min;
+    short max;
+    short step;
+    short defaultValue;
+    // Text shown in front of the current value e.g. `"Brightness: "`
+    const char *label;
+
+    // Upper case hexadecimal code e.g. `"E2"`
+    std::array<char, 3> hexCode;
+    // Start of the terse getvcp response e.g. `"VCP E2 "`, followed by the feature type
+    std::array<char, 8> responsePrefix;
+
+    constexpr short clamp(short value) const {
+      return value < min ? min : (value > max ? max : value);
+    }
+  };
+} // namespace VCP
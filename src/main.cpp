@@ -6,6 +6,8 @@
 // Qt Widgets https://doc.qt.io/qt-6/qtwidgets-index.html
 #include <QApplication>
 // ---
+#include <QCommandLineParser>
+#include <QDateTime>
 #include <QDir>
 #include <QHBoxLayout>
 #include <QLabel>
@@ -13,12 +15,22 @@
 #include <QMenu>
 #include <QMessageBox>
 #include <QPainter>
+#include <QPointer>
 #include <QPushButton>
 #include <QStyleOption>
+#include <QTextStream>
 #include <QWidget>
 
+#include <array>
+#include <chrono>
+#include <memory>
+
 #include "core/constants.h"
+#include "core/ddc-bus.h"
 #include "core/ddcutil-wrapper.h"
+#include "core/diagnostics.h"
+#include "core/history.h"
+#include "core/task.h"
 #include <KAboutData>
 #include <KStatusNotifierItem>
 
@@ -38,6 +50,9 @@ public:
 
   ~CustomWidget() { qApp->removeEventFilter(this); }
 
+signals:
+  void hidden();
+
 protected:
   // Required to add styling to the widget
   // https://doc.qt.io/qt-5/stylesheet-reference.html
@@ -58,6 +73,11 @@ protected:
     }
   }
 
+  void hideEvent(QHideEvent *event) override {
+    QWidget::hideEvent(event);
+    emit hidden();
+  }
+
   // Close when focus is lost due to clicking outside the application
   bool eventFilter(QObject *obj, QEvent *event) override {
     if (event->type() == QEvent::FocusOut) {
@@ -112,8 +132,115 @@ private:
   QPoint m_lastGlobal;
 };
 
-const QString CURRENT_BRIGHTNESS_TEXT = "Brightness: ";
-const QString CURRENT_CONTRAST_TEXT = "Contrast: ";
+// Periodic timer owned by a widget, running only while the widget is shown.
+// Fires once right away on show, as the values may have changed while hidden.
+class VisibleTimer : public QTimer {
+public:
+  VisibleTimer(int interval, QWidget *parent, std::function<void()> onTimeout)
+      : QTimer(parent), m_onTimeout(std::move(onTimeout)) {
+    setInterval(interval);
+    connect(this, &QTimer::timeout, this, [this]() { m_onTimeout(); });
+    parent->installEventFilter(this);
+  }
+
+protected:
+  bool eventFilter(QObject *obj, QEvent *event) override {
+    if (event->type() == QEvent::Show) {
+      start();
+      m_onTimeout();
+    } else if (event->type() == QEvent::Hide) {
+      stop();
+    }
+    return QTimer::eventFilter(obj, event);
+  }
+
+private:
+  std::function<void()> m_onTimeout;
+};
+
+// Brightness and ddcutil latencies over the last HISTORY_VIEW_DAYS, from the history file
+class HistoryView : public QWidget {
+public:
+  explicit HistoryView(QWidget *parent = nullptr) : QWidget(parent) { setMinimumSize(360, 140); }
+
+protected:
+  // Records are only held while the view is shown
+  void showEvent(QShowEvent *event) override {
+    m_records = History::records();
+    QWidget::showEvent(event);
+  }
+
+  void hideEvent(QHideEvent *event) override {
+    m_records = {};
+    QWidget::hideEvent(event);
+  }
+
+  void paintEvent(QPaintEvent *) override {
+    const auto &brightness = Constants::Display::Feature::BRIGHTNESS;
+    const qint64 end = QDateTime::currentMSecsSinceEpoch();
+    const qint64 start = end - qint64(Constants::Display::HISTORY_VIEW_DAYS) * 24 * 60 * 60 * 1000;
+    const QRectF plot = QRectF(rect()).adjusted(1, 20, -1, -1);
+    auto x = [&](qint64 timeMs) {
+      return plot.left() + plot.width() * (std::max(timeMs, start) - start) / double(end - start);
+    };
+    auto isFailure = [](const History::Record &record) {
+      return record.kind == History::Kind::GET_FAILED || record.kind == History::Kind::SET_FAILED;
+    };
+
+    // Latencies are scaled to the slowest call in the window
+    std::int32_t maxLatency = 1;
+    int sets = 0, failures = 0;
+    for (const History::Record &record : m_records) {
+      if (record.timeMs < start || record.kind == History::Kind::VALUE)
+        continue;
+      maxLatency = std::max(maxLatency, record.latencyMs);
+      sets += record.kind == History::Kind::SET;
+      failures += isFailure(record);
+    }
+
+    QPainter p(this);
+    p.setPen(palette().color(QPalette::Text));
+    p.drawText(rect(), Qt::AlignLeft | Qt::AlignTop,
+               QString("%1 days: %2 sets, %3 failed, slowest %4 ms")
+                   .arg(Constants::Display::HISTORY_VIEW_DAYS)
+                   .arg(sets)
+                   .arg(failures)
+                   .arg(maxLatency));
+
+    p.setPen(palette().color(QPalette::Mid));
+    p.drawRect(plot);
+
+    // One dot per ddcutil call, failures in red
+    for (const History::Record &record : m_records) {
+      if (record.timeMs < start || record.kind == History::Kind::VALUE)
+        continue;
+      p.setPen(isFailure(record) ? QColor(Qt::red) : palette().color(QPalette::Text));
+      p.drawPoint(QPointF(x(record.timeMs),
+                          plot.bottom() - plot.height() * record.latencyMs / maxLatency));
+    }
+
+    // Brightness as a step line, values from before the window start at its left edge
+    QPolygonF line;
+    for (const History::Record &record : m_records) {
+      if (record.kind != History::Kind::VALUE || record.code != brightness.code)
+        continue;
+      QPointF point(x(record.timeMs), plot.bottom() - plot.height() *
+                                                          (record.value - brightness.min) /
+                                                          (brightness.max - brightness.min));
+      if (!line.isEmpty())
+        line << QPointF(point.x(), line.last().y());
+      line << point;
+    }
+    if (!line.isEmpty())
+      line << QPointF(plot.right(), line.last().y());
+
+    p.setPen(QPen(palette().color(QPalette::Highlight), 2));
+    p.drawPolyline(line);
+  }
+
+private:
+  std::vector<History::Record> m_records;
+};
 
 /**
  * Handles enabling/disabling of increase/decrease buttons based on current value and range
@@ -132,78 +259,100 @@ void handleButtonStates(short currentValue, std::pair<short, short> range, auto
   }
 }
 
-void adjustProperty(QString vcpCode, short delta, short &currentValue,
-                    std::pair<short, short> range, auto *increaseBtn, auto *decreaseBtn,
-                    auto *currentValueLabel, QString PROPERTY_LABEL) {
+// Last known VCP values, indexed by code. Shared by the tray menu, the popup and any coroutine
+// still waiting on ddcutil, so it stays valid for as long as one of them holds it.
+struct DisplayState {
+  std::array<short, 256> values{};
 
-  increaseBtn->setEnabled(false);
-  decreaseBtn->setEnabled(false);
+  template <const VCP::FeatureDescriptor &Feature> short &value() { return values[Feature.code]; }
+};
+using DisplayStatePtr = std::shared_ptr<DisplayState>;
+
+// Widgets of a continuous property, all owned by `widget`
+struct PropertyControls {
+  QWidget *widget;
+  QPushButton *increaseButton;
+  QPushButton *decreaseButton;
+  QLabel *valueLabel;
+};
 
-  short newValue = currentValue + delta;
+/**
+ * Shows a new value in the controls built by createContinuousPropertyWidget
+ */
+template <const VCP::FeatureDescriptor &Feature>
+void showPropertyValue(const PropertyControls &controls, short currentValue) {
+  handleButtonStates(currentValue, {Feature.min, Feature.max}, controls.increaseButton,
+                     controls.decreaseButton);
+  controls.valueLabel->setText(Feature.label + QString::number(currentValue));
+}
 
-  auto [minValue, maxValue] = range;
-  if (newValue > maxValue)
-    newValue = maxValue;
-  else if (newValue < minValue)
-    newValue = minValue;
+template <const VCP::FeatureDescriptor &Feature>
+Task adjustProperty(short delta, DisplayStatePtr state, PropertyControls controls) {
+  controls.increaseButton->setEnabled(false);
+  controls.decreaseButton->setEnabled(false);
 
-  setVCPValueAsync(vcpCode, newValue,
-                   [increaseBtn, decreaseBtn, currentValueLabel, PROPERTY_LABEL, range,
-                    &currentValue, newValue](int exitCode) mutable {
-                     if (exitCode != 0) {
-                       qDebug() << "Failed to change property:" << exitCode;
-                     } else {
-                       qDebug() << "Property changed successfully!";
-                       currentValue = newValue;
-                     }
+  short newValue = Feature.clamp(state->value<Feature>() + delta);
 
-                     QTimer::singleShot(0, [increaseBtn, decreaseBtn, currentValueLabel,
-                                            PROPERTY_LABEL, range, &currentValue]() {
-                       handleButtonStates(currentValue, range, increaseBtn, decreaseBtn);
+  // Application as context, the value outlives the popup
+  QPointer popupAlive(controls.widget);
+  int exitCode = co_await setVCPValueAsync<Feature>(qApp, newValue);
 
-                       currentValueLabel->setText(PROPERTY_LABEL + QString::number(currentValue));
-                     });
-                   });
+  if (exitCode != 0) {
+    qDebug() << "Failed to change property:" << exitCode;
+  } else {
+    qDebug() << "Property changed successfully!";
+    state->value<Feature>() = newValue;
+  }
+
+  if (!popupAlive)
+    co_return;
+
+  showPropertyValue<Feature>(controls, state->value<Feature>());
+}
+
+template <const VCP::FeatureDescriptor &Feature>
+Task refreshProperty(DisplayStatePtr state, PropertyControls controls) {
+  short newValue = co_await getVCPValueAsync<Feature>(controls.widget);
+  if (newValue == -1)
+    co_return;
+
+  state->value<Feature>() = newValue;
+  showPropertyValue<Feature>(controls, newValue);
 }
 
-QMenu *createContextMenu(const short &currentBrightness, const short &currentContrast,
-                         QApplication &app) {
+QMenu *createContextMenu(DisplayStatePtr state, QApplication &app) {
   QMenu *contextMenu = new QMenu();
 
-  QAction *brightnessAction =
-      contextMenu->addAction(CURRENT_BRIGHTNESS_TEXT + QString::number(currentBrightness));
+  QAction *brightnessAction = contextMenu->addAction(
+      Constants::Display::Feature::BRIGHTNESS.label +
+      QString::number(state->value<Constants::Display::Feature::BRIGHTNESS>()));
   brightnessAction->setEnabled(false);
 
   // QAction *increaseBrightnessAction =
-  //     contextMenu->addAction("+" + QString::number(Constants::Display::Brightness::STEP));
+  //     contextMenu->addAction("+" +
+  //     QString::number(Constants::Display::Feature::BRIGHTNESS.step));
   // QAction *decreaseBrightnessAction =
-  //     contextMenu->addAction("-" + QString::number(Constants::Display::Brightness::STEP));
+  //     contextMenu->addAction("-" +
+  //     QString::number(Constants::Display::Feature::BRIGHTNESS.step));
 
   // QObject::connect(
   //     increaseBrightnessAction, &QAction::triggered,
-  //     [increaseBrightnessAction, decreaseBrightnessAction, brightnessAction,
-  //     &currentBrightness]() {
-  //       adjustProperty(
-  //           QString::number(Constants::MCCS::VCPCode::std::BRIGHTNESS, 16),
-  //           Constants::Display::Brightness::STEP, currentBrightness,
-  //           {Constants::Display::CONTINUOUS_FEATURE_MIN, Constants::Display::Brightness::MAX},
-  //           increaseBrightnessAction, decreaseBrightnessAction, brightnessAction,
-  //           CURRENT_BRIGHTNESS_TEXT);
+  //     [increaseBrightnessAction, decreaseBrightnessAction, brightnessAction, state]() {
+  //       adjustProperty<Constants::Display::Feature::BRIGHTNESS>(
+  //           Constants::Display::Feature::BRIGHTNESS.step, state,
+  //           {increaseBrightnessAction, decreaseBrightnessAction, brightnessAction});
   //     });
   // QObject::connect(
   //     decreaseBrightnessAction, &QAction::triggered,
-  //     [increaseBrightnessAction, decreaseBrightnessAction, brightnessAction,
-  //     &currentBrightness]() {
-  //       adjustProperty(
-  //           QString::number(Constants::MCCS::VCPCode::std::BRIGHTNESS, 16),
-  //           -Constants::Display::Brightness::STEP, currentBrightness,
-  //           {Constants::Display::CONTINUOUS_FEATURE_MIN, Constants::Display::Brightness::MAX},
-  //           increaseBrightnessAction, decreaseBrightnessAction, brightnessAction,
-  //           CURRENT_BRIGHTNESS_TEXT);
+  //     [increaseBrightnessAction, decreaseBrightnessAction, brightnessAction, state]() {
+  //       adjustProperty<Constants::Display::Feature::BRIGHTNESS>(
+  //           -Constants::Display::Feature::BRIGHTNESS.step, state,
+  //           {increaseBrightnessAction, decreaseBrightnessAction, brightnessAction});
   //     });
 
-  QAction *contrastAction =
-      contextMenu->addAction(CURRENT_CONTRAST_TEXT + QString::number(currentContrast));
+  QAction *contrastAction = contextMenu->addAction(
+      Constants::Display::Feature::CONTRAST.label +
+      QString::number(state->value<Constants::Display::Feature::CONTRAST>()));
   contrastAction->setEnabled(false);
 
   QAction *quitAction = contextMenu->addAction("Quit");
@@ -212,24 +361,36 @@ QMenu *createContextMenu(const short &currentBrightness, const short &currentCon
   // Update the current brightness and contrast when the context menu is shown
   QObject::connect(
       contextMenu, &QMenu::aboutToShow,
-      [brightnessAction, contrastAction, &currentBrightness, &currentContrast]() {
-        brightnessAction->setText(CURRENT_BRIGHTNESS_TEXT + QString::number(currentBrightness));
-        contrastAction->setText(CURRENT_CONTRAST_TEXT + QString::number(currentContrast));
+      [brightnessAction, contrastAction, state]() {
+        brightnessAction->setText(
+            Constants::Display::Feature::BRIGHTNESS.label +
+            QString::number(state->value<Constants::Display::Feature::BRIGHTNESS>()));
+        contrastAction->setText(
+            Constants::Display::Feature::CONTRAST.label +
+            QString::number(state->value<Constants::Display::Feature::CONTRAST>()));
       });
 
   return contextMenu;
 }
 
-auto createContinuousPropertyWidget(const QString &labelText, short &currentValue, short step,
-                                    std::pair<short, short> range, QString vcpCode) {
+/**
+ * Creates -/+ buttons around the current value of any continuous feature
+ */
+template <const VCP::FeatureDescriptor &Feature>
+PropertyControls createContinuousPropertyWidget(DisplayStatePtr state) {
+  static_assert(Feature.type == VCP::FeatureType::CONTINUOUS,
+                "Only continuous features can be stepped");
+
   QWidget *propertyWidget = new QWidget();
 
   QHBoxLayout *propertyLayout = new QHBoxLayout(propertyWidget);
   propertyWidget->setLayout(propertyLayout);
 
-  QLabel *propertyLabel = new QLabel(labelText + QString::number(currentValue));
-  QPushButton *increaseButton = new QPushButton("+" + QString::number(step));
-  QPushButton *decreaseButton = new QPushButton("-" + QString::number(step));
+  const short currentValue = state->value<Feature>();
+  QLabel *propertyLabel = new QLabel(Feature.label + QString::number(currentValue));
+  QPushButton *increaseButton = new QPushButton("+" + QString::number(Feature.step));
+  QPushButton *decreaseButton = new QPushButton("-" + QString::number(Feature.step));
+  const PropertyControls controls{propertyWidget, increaseButton, decreaseButton, propertyLabel};
   propertyLayout->addWidget(decreaseButton);
   propertyLayout->addSpacing(10);
 
@@ -240,29 +401,22 @@ auto createContinuousPropertyWidget(const QString &labelText, short &currentValu
   propertyLayout->addSpacing(10);
   propertyLayout->addWidget(increaseButton);
 
-  if (currentValue == range.first)
+  if (currentValue == Feature.min)
     decreaseButton->setEnabled(false);
-  else if (currentValue == range.second)
+  else if (currentValue == Feature.max)
     increaseButton->setEnabled(false);
 
-  QObject::connect(increaseButton, &QPushButton::clicked,
-                   [increaseButton, decreaseButton, propertyLabel, &currentValue, step, range,
-                    vcpCode, labelText]() {
-                     adjustProperty(vcpCode, step, currentValue, range, increaseButton,
-                                    decreaseButton, propertyLabel, labelText);
-                   });
-  QObject::connect(decreaseButton, &QPushButton::clicked,
-                   [increaseButton, decreaseButton, propertyLabel, &currentValue, step, range,
-                    vcpCode, labelText]() {
-                     adjustProperty(vcpCode, -step, currentValue, range, increaseButton,
-                                    decreaseButton, propertyLabel, labelText);
-                   });
-
-  // Refresh the current value periodically
-  QTimer *timer = new QTimer();
-  QObject::connect(
-      timer, &QTimer::timeout,
-      [propertyLabel, labelText, &currentValue, vcpCode, range, increaseButton, decreaseButton]() {
+  QObject::connect(increaseButton, &QPushButton::clicked, [state, controls]() {
+    adjustProperty<Feature>(Feature.step, state, controls);
+  });
+  QObject::connect(decreaseButton, &QPushButton::clicked, [state, controls]() {
+    adjustProperty<Feature>(-Feature.step, state, controls);
+  });
+
+  // Refresh the current value periodically, while the popup is shown
+  new VisibleTimer(
+      Constants::Display::REFRESH_INTERVAL, propertyWidget,
+      [state, controls, increaseButton, decreaseButton]() {
         // Skip the refresh to avoid races/overwrites.
         if (!increaseButton->isEnabled() && !decreaseButton->isEnabled()) {
           qDebug() << "Property change in progress. Skipping refresh.";
@@ -270,7 +424,7 @@ auto createContinuousPropertyWidget(const QString &labelText, short &currentValu
         }
 
         // Prevent waking up the monitor if it's off
-        const QString path_base = "/sys/class/drm/card1-HDMI-A-1";
+        const QString path_base = Constants::Display::DRM_CONNECTOR;
         const QString path_status = path_base + "/status";
         const QString path_enabled = path_base + "/enabled";
 
@@ -295,44 +449,96 @@ auto createContinuousPropertyWidget(const QString &labelText, short &currentValu
           return;
         }
 
-        getVCPValueAsync(vcpCode, [propertyLabel, labelText, &currentValue, range, increaseButton,
-                                   decreaseButton](short newValue) {
-          if (newValue != -1) {
-            currentValue = newValue;
-            handleButtonStates(currentValue, range, increaseButton, decreaseButton);
-            propertyLabel->setText(labelText + QString::number(currentValue));
-          }
-        });
+        refreshProperty<Feature>(state, controls);
       });
-  timer->start(Constants::Display::REFRESH_INTERVAL);
 
-  return propertyWidget;
+  return controls;
 };
 
-auto createModeWidget(short &currentMode, QWidget *brightnessWidget, QWidget *contrastWidget) {
+using ModeButtons = std::map<short, QPushButton *>;
+
+Task changeMode(short newMode, DisplayStatePtr state, std::shared_ptr<ModeButtons> modeButtons,
+                PropertyControls brightnessControls, PropertyControls contrastControls) {
+  QWidget *brightnessWidget = brightnessControls.widget;
+  QWidget *contrastWidget = contrastControls.widget;
+  short &currentMode = state->value<Constants::Display::Feature::ACER_XV272UV3_MODE>();
+
+  for (auto &kv : *modeButtons)
+    kv.second->setEnabled(false);
+
+  // Application as context, the mode outlives the popup
+  QPointer popupAlive(brightnessWidget);
+  int exitCode =
+      co_await setVCPValueAsync<Constants::Display::Feature::ACER_XV272UV3_MODE>(qApp, newMode);
+
+  if (exitCode == 0)
+    currentMode = newMode;
+  if (!popupAlive)
+    co_return;
+
+  if (exitCode != 0) {
+    qDebug() << "Failed to change the mode:" << exitCode;
+  } else {
+    qDebug() << "Mode changed successfully!";
+
+    brightnessWidget->setEnabled(
+        newMode == Constants::MCCS::VCPCode::Manufacturer::AcerXV272UV3::ModeValue::USER ||
+        newMode >= Constants::MCCS::VCPCode::Manufacturer::AcerXV272UV3::ModeValue::GAME_ACTION);
+    contrastWidget->setEnabled(
+        newMode == Constants::MCCS::VCPCode::Manufacturer::AcerXV272UV3::ModeValue::USER ||
+        newMode >= Constants::MCCS::VCPCode::Manufacturer::AcerXV272UV3::ModeValue::GAME_ACTION);
+  }
+
+  for (auto &kv : *modeButtons) {
+    kv.second->setEnabled(kv.first != currentMode);
+  }
+
+  if (exitCode != 0)
+    co_return;
+
+  // Each mode has its own brightness and contrast
+  auto [brightness, contrast] =
+      co_await getVCPValuesAsync<Constants::Display::Feature::BRIGHTNESS,
+                                 Constants::Display::Feature::CONTRAST>(brightnessWidget);
+
+  if (brightness != -1) {
+    state->value<Constants::Display::Feature::BRIGHTNESS>() = brightness;
+    showPropertyValue<Constants::Display::Feature::BRIGHTNESS>(brightnessControls, brightness);
+  }
+  if (contrast != -1) {
+    state->value<Constants::Display::Feature::CONTRAST>() = contrast;
+    showPropertyValue<Constants::Display::Feature::CONTRAST>(contrastControls, contrast);
+  }
+}
+
+auto createModeWidget(DisplayStatePtr state, PropertyControls brightnessControls,
+                      PropertyControls contrastControls) {
+  QWidget *brightnessWidget = brightnessControls.widget;
+  QWidget *contrastWidget = contrastControls.widget;
+  const short currentMode = state->value<Constants::Display::Feature::ACER_XV272UV3_MODE>();
+
   QWidget *modeWidget = new QWidget();
   QGridLayout *modeLayout = new QGridLayout(modeWidget);
   modeWidget->setLayout(modeLayout);
 
   // Using a pointer to persist beyond function scope
-  auto modeButtons =
-      std::make_shared<std::map<short, QPushButton *>>(std::map<short, QPushButton *>{
-          {Constants::MCCS::VCPCode::Manufacturer::AcerXV272UV3::ModeValue::USER,
-           new QPushButton("User")},
-          {Constants::MCCS::VCPCode::Manufacturer::AcerXV272UV3::ModeValue::STANDARD,
-           new QPushButton("Standard")},
-          {Constants::MCCS::VCPCode::Manufacturer::AcerXV272UV3::ModeValue::ECO,
-           new QPushButton("Eco")},
-          {Constants::MCCS::VCPCode::Manufacturer::AcerXV272UV3::ModeValue::GRAPHICS,
-           new QPushButton("Graphics")},
-          {Constants::MCCS::VCPCode::Manufacturer::AcerXV272UV3::ModeValue::GAME_ACTION,
-           new QPushButton("G-Action")},
-          {Constants::MCCS::VCPCode::Manufacturer::AcerXV272UV3::ModeValue::GAME_RACING,
-           new QPushButton("G-Racing")},
-          {Constants::MCCS::VCPCode::Manufacturer::AcerXV272UV3::ModeValue::GAME_SPORTS,
-           new QPushButton("G-Sports")},
-          {Constants::MCCS::VCPCode::Manufacturer::AcerXV272UV3::ModeValue::HDR,
-           new QPushButton("HDR")}});
+  auto modeButtons = std::make_shared<ModeButtons>(ModeButtons{
+      {Constants::MCCS::VCPCode::Manufacturer::AcerXV272UV3::ModeValue::USER,
+       new QPushButton("User")},
+      {Constants::MCCS::VCPCode::Manufacturer::AcerXV272UV3::ModeValue::STANDARD,
+       new QPushButton("Standard")},
+      {Constants::MCCS::VCPCode::Manufacturer::AcerXV272UV3::ModeValue::ECO,
+       new QPushButton("Eco")},
+      {Constants::MCCS::VCPCode::Manufacturer::AcerXV272UV3::ModeValue::GRAPHICS,
+       new QPushButton("Graphics")},
+      {Constants::MCCS::VCPCode::Manufacturer::AcerXV272UV3::ModeValue::GAME_ACTION,
+       new QPushButton("G-Action")},
+      {Constants::MCCS::VCPCode::Manufacturer::AcerXV272UV3::ModeValue::GAME_RACING,
+       new QPushButton("G-Racing")},
+      {Constants::MCCS::VCPCode::Manufacturer::AcerXV272UV3::ModeValue::GAME_SPORTS,
+       new QPushButton("G-Sports")},
+      {Constants::MCCS::VCPCode::Manufacturer::AcerXV272UV3::ModeValue::HDR,
+       new QPushButton("HDR")}});
 
   // Disable current mode button
   (*modeButtons)[currentMode]->setEnabled(false);
@@ -345,115 +551,26 @@ auto createModeWidget(short &currentMode, QWidget *brightnessWidget, QWidget *co
       currentMode == Constants::MCCS::VCPCode::Manufacturer::AcerXV272UV3::ModeValue::USER ||
       currentMode >= Constants::MCCS::VCPCode::Manufacturer::AcerXV272UV3::ModeValue::GAME_ACTION);
 
-  auto changeMode = [brightnessWidget, contrastWidget, modeButtons, &currentMode](short newMode) {
-    for (auto &kv : *modeButtons)
-      kv.second->setEnabled(false);
-
-    setVCPValueAsync(
-        QString::number(Constants::MCCS::VCPCode::Manufacturer::AcerXV272UV3::Code::MODE, 16),
-        newMode,
-        [modeButtons, brightnessWidget, contrastWidget, &currentMode,
-         newMode](int exitCode) mutable {
-          QTimer::singleShot(0, [modeButtons, brightnessWidget, contrastWidget, &currentMode,
-                                 newMode, exitCode]() {
-            if (exitCode != 0) {
-              qDebug() << "Failed to change the mode:" << exitCode;
-            } else {
-              qDebug() << "Mode changed successfully!";
-
-              brightnessWidget->setEnabled(
-                  newMode ==
-                      Constants::MCCS::VCPCode::Manufacturer::AcerXV272UV3::ModeValue::USER ||
-                  newMode >=
-                      Constants::MCCS::VCPCode::Manufacturer::AcerXV272UV3::ModeValue::GAME_ACTION);
-              contrastWidget->setEnabled(
-                  newMode ==
-                      Constants::MCCS::VCPCode::Manufacturer::AcerXV272UV3::ModeValue::USER ||
-                  newMode >=
-                      Constants::MCCS::VCPCode::Manufacturer::AcerXV272UV3::ModeValue::GAME_ACTION);
-
-              currentMode = newMode;
-            }
-
-            for (auto &kv : *modeButtons) {
-              kv.second->setEnabled(kv.first != currentMode);
-            }
-          });
-        });
-  };
-
   short i = 0, cols = 4;
   for (auto &[mode, button] : *modeButtons) {
     modeLayout->addWidget(button, i / cols, i % cols);
     i++;
-    QObject::connect(button, &QPushButton::clicked, [mode, changeMode]() { changeMode(mode); });
+    QObject::connect(button, &QPushButton::clicked,
+                     [mode, state, modeButtons, brightnessControls, contrastControls]() {
+                       changeMode(mode, state, modeButtons, brightnessControls,
+                                  contrastControls);
+                     });
   }
 
   return modeWidget;
 }
 
-int main(int argc, char *argv[]) {
-  QApplication app(argc, argv);
-
-  QString programName = "display-vcp";
-  QString displayName = "Display VCP";
-  QString programVersion = "0.2";
-  QString programDescription = "Virtual Control Panel app to control display features "
-                               "like brightness, contrast, etc. available on KDE system tray";
-
-  QString lockFilePath = QDir::temp().filePath("display-vcp.lock");
-  QLockFile lockFile(lockFilePath);
-  if (!lockFile.tryLock(100)) {
-    qDebug() << "Another instance is already running. Exiting.";
-    QMessageBox::warning(nullptr, displayName, displayName + " is already running.");
-    return 0;
-  }
-
-  // Application metadata
-  KAboutData aboutData(programName, displayName, programVersion, programDescription,
-                       KAboutLicense::Unknown);
-  KAboutData::setApplicationData(aboutData);
-
-  // Create a status notifier item (system tray icon)
-  KStatusNotifierItem *trayIcon = new KStatusNotifierItem();
-  trayIcon->setTitle(displayName);
-  trayIcon->setToolTipTitle(displayName);
-  trayIcon->setCategory(KStatusNotifierItem::Hardware);
-
-  // Use a KDE icon name or path to your icon. See /usr/share/icons/
-  trayIcon->setIconByName("monitor");
-  trayIcon->setIconByName("video-display");
-  trayIcon->setIconByName("video-display-symbolic");
-  trayIcon->setIconByName("video-display-brightness");
-
-  // Disable the default actions (including the default Quit action)
-  trayIcon->setStandardActionsEnabled(false);
-
-  short currentBrightness =
-      getVCPValue(QString::number(Constants::MCCS::VCPCode::std::BRIGHTNESS, 16));
-  if (currentBrightness == -1) {
-    qDebug() << "Failed to get the current brightness!";
-    currentBrightness = Constants::Display::Brightness::DEFAULT;
-  }
-
-  short currentContrast = getVCPValue(QString::number(Constants::MCCS::VCPCode::std::CONTRAST, 16));
-  if (currentContrast == -1) {
-    qDebug() << "Failed to get the current contrast!";
-    currentContrast = Constants::Display::Contrast::DEFAULT;
-  }
-
-  short currentMode = getVCPValue(
-      QString::number(Constants::MCCS::VCPCode::Manufacturer::AcerXV272UV3::Code::MODE, 16));
-
-  if (currentMode == -1) {
-    qDebug() << "Failed to get the current mode!";
-    currentMode = Constants::MCCS::VCPCode::Manufacturer::AcerXV272UV3::ModeValue::USER;
-  }
-
-  trayIcon->setContextMenu(createContextMenu(currentBrightness, currentContrast, app));
-
 #pragma region Main control UI
 
+/**
+ * Builds the main control UI, every widget and timer is owned by the returned window
+ */
+CustomWidget *createControlPopup(const QString &title, DisplayStatePtr state) {
   CustomWidget *mainWidget = new CustomWidget();
   mainWidget->setWindowFlags(Qt::Tool | Qt::FramelessWindowHint);
   mainWidget->setFont(QFont("Monospace"));
@@ -489,12 +606,12 @@ int main(int argc, char *argv[]) {
 
   mainLayout->insertWidget(0, headerWidget);
 
-  QTimer::singleShot(0, [dragButton1, dragButton2]() {
+  QTimer::singleShot(0, mainWidget, [dragButton1, dragButton2]() {
     dragButton1->raise();
     dragButton2->raise();
   });
 
-  QLabel *titleLabel = new QLabel(displayName + " v" + programVersion);
+  QLabel *titleLabel = new QLabel(title);
 
   QFont titleFont = titleLabel->font();
   titleFont.setPointSize(14);
@@ -505,18 +622,14 @@ int main(int argc, char *argv[]) {
   headerLayout->addStretch();
   headerLayout->addWidget(dragButton2);
 
-  QWidget *brightnessWidget = createContinuousPropertyWidget(
-      CURRENT_BRIGHTNESS_TEXT, currentBrightness, Constants::Display::Brightness::STEP,
-      {Constants::Display::CONTINUOUS_FEATURE_MIN, Constants::Display::Brightness::MAX},
-      QString::number(Constants::MCCS::VCPCode::std::BRIGHTNESS, 16));
-  QWidget *contrastWidget = createContinuousPropertyWidget(
-      CURRENT_CONTRAST_TEXT, currentContrast, Constants::Display::Contrast::STEP,
-      {Constants::Display::CONTINUOUS_FEATURE_MIN, Constants::Display::Contrast::MAX},
-      QString::number(Constants::MCCS::VCPCode::std::CONTRAST, 16));
-  mainLayout->addWidget(brightnessWidget);
-  mainLayout->addWidget(contrastWidget);
+  PropertyControls brightnessControls =
+      createContinuousPropertyWidget<Constants::Display::Feature::BRIGHTNESS>(state);
+  PropertyControls contrastControls =
+      createContinuousPropertyWidget<Constants::Display::Feature::CONTRAST>(state);
+  mainLayout->addWidget(brightnessControls.widget);
+  mainLayout->addWidget(contrastControls.widget);
 
-  QWidget *modeWidget = createModeWidget(currentMode, brightnessWidget, contrastWidget);
+  QWidget *modeWidget = createModeWidget(state, brightnessControls, contrastControls);
 
   mainLayout->addWidget(modeWidget);
 
@@ -530,11 +643,176 @@ int main(int argc, char *argv[]) {
   okayLayout->addStretch(); // flex space
   QObject::connect(okayButton, &QPushButton::clicked, [mainWidget]() { mainWidget->close(); });
 
+  // History above the okay button, hidden until requested
+  HistoryView *historyView = new HistoryView();
+  historyView->hide();
+  mainLayout->insertWidget(mainLayout->indexOf(okayWidget), historyView);
+  QPushButton *historyButton = new QPushButton("History");
+  historyButton->setCheckable(true);
+  okayLayout->addWidget(historyButton);
+  QObject::connect(historyButton, &QPushButton::toggled, [historyView, mainWidget](bool checked) {
+    historyView->setVisible(checked);
+    mainWidget->adjustSize();
+  });
+
+  return mainWidget;
+}
+
 #pragma endregion
 
+int main(int argc, char *argv[]) {
+  QApplication app(argc, argv);
+
+  QString programName = "display-vcp";
+  QString displayName = "Display VCP";
+  QString programVersion = "0.2";
+  QString programDescription = "Virtual Control Panel app to control display features "
+                               "like brightness, contrast, etc. available on KDE system tray";
+
+  // Application metadata
+  KAboutData aboutData(programName, displayName, programVersion, programDescription,
+                       KAboutLicense::Unknown);
+  KAboutData::setApplicationData(aboutData);
+
+  QCommandLineParser parser;
+  aboutData.setupCommandLine(&parser);
+  QCommandLineOption popupIdleTimeoutOption(
+      "popup-idle-timeout",
+      "Free the control popup after it stayed closed for <seconds>, at most one day.",
+      "seconds", QString::number(Constants::Display::POPUP_IDLE_TIMEOUT));
+  parser.addOption(popupIdleTimeoutOption);
+  QCommandLineOption dumpHistoryOption(
+      "dump-history", "Print the recorded values and ddcutil latencies, then exit.");
+  parser.addOption(dumpHistoryOption);
+  QCommandLineOption dumpCacheOption(
+      "dump-cache", "Print the values shared with other processes and their age, then exit.");
+  parser.addOption(dumpCacheOption);
+  parser.process(app);
+  aboutData.processCommandLine(&parser);
+
+  // Tab separated: time, kind, VCP code, value, latency in ms
+  if (parser.isSet(dumpHistoryOption)) {
+    std::vector<History::Record> records;
+    if (!History::readRecords(records))
+      return 1;
+
+    QTextStream out(stdout);
+    for (const History::Record &record : records) {
+      out << QDateTime::fromMSecsSinceEpoch(record.timeMs).toString(Qt::ISODateWithMs) << '\t'
+          << History::kindName(record.kind) << '\t'
+          << QString::number(record.code, 16).toUpper() << '\t' << record.value << '\t'
+          << record.latencyMs << '\n';
+    }
+    return 0;
+  }
+
+  // Tab separated: VCP code, value, age in ms, fresh or stale
+  if (parser.isSet(dumpCacheOption)) {
+    std::vector<SharedValueCache::Entry> entries;
+    if (!SharedValueCache::readEntries(entries))
+      return 1;
+
+    QTextStream out(stdout);
+    for (const SharedValueCache::Entry &entry : entries) {
+      out << QString::number(entry.code, 16).toUpper() << '\t' << entry.value << '\t'
+          << entry.ageMs << '\t'
+          << (entry.ageMs <= static_cast<std::uint64_t>(Constants::Display::CACHE_MAX_AGE)
+                  ? "fresh"
+                  : "stale")
+          << '\n';
+    }
+    return 0;
+  }
+
+  bool validTimeout = false;
+  int popupIdleTimeout = parser.value(popupIdleTimeoutOption).toInt(&validTimeout);
+  if (!validTimeout || popupIdleTimeout < 0 ||
+      popupIdleTimeout > Constants::Display::POPUP_IDLE_TIMEOUT_MAX) {
+    qDebug() << "Invalid popup idle timeout, using the default.";
+    popupIdleTimeout = Constants::Display::POPUP_IDLE_TIMEOUT;
+  }
+
+  QString lockFilePath = QDir::temp().filePath("display-vcp.lock");
+  QLockFile lockFile(lockFilePath);
+  if (!lockFile.tryLock(100)) {
+    qDebug() << "Another instance is already running. Exiting.";
+    QMessageBox::warning(nullptr, displayName, displayName + " is already running.");
+    return 0;
+  }
+
+  // Create a status notifier item (system tray icon)
+  KStatusNotifierItem *trayIcon = new KStatusNotifierItem(&app);
+  trayIcon->setTitle(displayName);
+  trayIcon->setToolTipTitle(displayName);
+  trayIcon->setCategory(KStatusNotifierItem::Hardware);
+
+  // Use a KDE icon name or path to your icon. See /usr/share/icons/
+  trayIcon->setIconByName("monitor");
+  trayIcon->setIconByName("video-display");
+  trayIcon->setIconByName("video-display-symbolic");
+  trayIcon->setIconByName("video-display-brightness");
+
+  // Disable the default actions (including the default Quit action)
+  trayIcon->setStandardActionsEnabled(false);
+
+  auto state = std::make_shared<DisplayState>();
+
+  short &currentBrightness = state->value<Constants::Display::Feature::BRIGHTNESS>();
+  currentBrightness = getVCPValue<Constants::Display::Feature::BRIGHTNESS>();
+  if (currentBrightness == -1) {
+    qDebug() << "Failed to get the current brightness!";
+    currentBrightness = Constants::Display::Feature::BRIGHTNESS.defaultValue;
+  }
+
+  short &currentContrast = state->value<Constants::Display::Feature::CONTRAST>();
+  currentContrast = getVCPValue<Constants::Display::Feature::CONTRAST>();
+  if (currentContrast == -1) {
+    qDebug() << "Failed to get the current contrast!";
+    currentContrast = Constants::Display::Feature::CONTRAST.defaultValue;
+  }
+
+  short &currentMode = state->value<Constants::Display::Feature::ACER_XV272UV3_MODE>();
+  currentMode = getVCPValue<Constants::Display::Feature::ACER_XV272UV3_MODE>();
+
+  if (currentMode == -1) {
+    qDebug() << "Failed to get the current mode!";
+    currentMode = Constants::Display::Feature::ACER_XV272UV3_MODE.defaultValue;
+  }
+
+  // The tray icon takes ownership of the menu
+  trayIcon->setContextMenu(createContextMenu(state, app));
+
+  // The popup is only built when first requested and freed again after staying closed for
+  // popupIdleTimeout, as it is closed most of the time
+  QPointer<CustomWidget> mainWidget;
+
+  QTimer *popupIdleTimer = new QTimer(&app);
+  popupIdleTimer->setSingleShot(true);
+  popupIdleTimer->setInterval(std::chrono::seconds(popupIdleTimeout));
+  QObject::connect(popupIdleTimer, &QTimer::timeout, [&mainWidget]() {
+    if (!mainWidget || mainWidget->isVisible())
+      return;
+
+    mainWidget->deleteLater();
+    mainWidget.clear();
+    // Deleted on the next event loop iteration
+    QTimer::singleShot(0, []() { qDebug() << "Control popup freed." << processStats(); });
+  });
+
+  qDebug() << "Started." << processStats();
+
   // Left-click on the tray icon
   // 1. Show main control UI
-  QObject::connect(trayIcon, &KStatusNotifierItem::activateRequested, [mainWidget]() {
+  QObject::connect(trayIcon, &KStatusNotifierItem::activateRequested, [&]() {
+    popupIdleTimer->stop();
+
+    if (!mainWidget) {
+      mainWidget = createControlPopup(displayName + " v" + programVersion, state);
+      QObject::connect(mainWidget, &CustomWidget::hidden, popupIdleTimer,
+                       qOverload<>(&QTimer::start));
+      qDebug() << "Control popup built." << processStats();
+    }
+
     if (mainWidget->isVisible()) {
       mainWidget->close();
       return;